@@ -0,0 +1,339 @@
+//
+// Compact binary format for the decoded time-evolving dead map (DeadMapQA_tMAP.dmap)
+//
+// Layout (little endian):
+//   header:  "ITSDMAP1" | uint32 format version
+//   blocks of up to STEPS_PER_BLOCK steps. The first step of a block stores its absolute orbit,
+//   the others the orbit difference from the previous step:
+//     step:  varint orbit (or orbit delta) | varint number of words | words (uint16)
+//   words use the same interval encoding of the TimeDeadMap: a chip ID, or (first | 0x8000),last
+//   index:   for each block: uint64 first orbit | uint64 file offset | uint32 first step | uint32 number of steps
+//   trailer: uint64 index offset | uint32 number of blocks | uint64 number of steps | "ITSDIDX1"
+//
+// The writer streams steps to disk keeping a single block in memory. The reader loads the index
+// only, and decodes the blocks containing the requested steps. Offsets, lengths and varints read from
+// the file are checked against the file and block sizes: a truncated or corrupted file makes open or
+// the read functions return false.
+//
+
+#ifndef DEAD_MAP_BINARY_H
+#define DEAD_MAP_BINARY_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace deadmapbin {
+
+const char HEADER_MAGIC[9] = "ITSDMAP1";
+const char TRAILER_MAGIC[9] = "ITSDIDX1";
+const uint32_t FORMAT_VERSION = 1;
+const int STEPS_PER_BLOCK = 64;
+
+struct BlockIndex {
+  uint64_t firstOrbit = 0;
+  uint64_t offset = 0;
+  uint32_t firstStep = 0;
+  uint32_t nSteps = 0;
+};
+
+// sorted chip list -> interval coded words
+inline void EncodeChips(const std::vector<uint16_t>& chips, std::vector<uint16_t>& words){
+  words.clear();
+  for (size_t i = 0; i < chips.size(); ){
+    size_t j = i;
+    while (j+1 < chips.size() && chips[j+1] == chips[j]+1) j++;
+    if (j == i){
+      words.push_back(chips[i]);
+    }
+    else {
+      words.push_back(chips[i] | 0x8000);
+      words.push_back(chips[j]);
+    }
+    i = j+1;
+  }
+}
+
+// interval coded words -> sorted chip list
+inline void DecodeWords(const std::vector<uint16_t>& words, std::vector<uint16_t>& chips){
+  chips.clear();
+  for (size_t i = 0; i < words.size(); i++){
+    uint16_t first = words[i], last = words[i];
+    if ((words[i] & 0x8000) && i+1 < words.size()){
+      first = words[i] & 0x7FFF;
+      last = words[++i];
+    }
+    for (uint32_t c = first; c <= last; c++) chips.push_back(c);
+  }
+}
+
+inline void PutVarint(std::vector<char>& buf, uint64_t v){
+  while (v >= 0x80){
+    buf.push_back((char)(v | 0x80));
+    v >>= 7;
+  }
+  buf.push_back((char)v);
+}
+
+// false if the varint runs past "end" or is longer than 64 bits
+inline bool GetVarint(const char*& p, const char* end, uint64_t& v){
+  v = 0;
+  for (int shift = 0; shift < 64; shift += 7){
+    if (p >= end) return false;
+    uint8_t b = (uint8_t)*p++;
+    v |= (uint64_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+template <typename T>
+inline void PutLE(std::vector<char>& buf, T v){
+  for (size_t i = 0; i < sizeof(T); i++) buf.push_back((char)((v >> (8*i)) & 0xFF));
+}
+
+template <typename T>
+inline T GetLE(const char* p){
+  T v = 0;
+  for (size_t i = 0; i < sizeof(T); i++) v |= (T)(uint8_t)p[i] << (8*i);
+  return v;
+}
+
+
+class Writer {
+public:
+  ~Writer() { close(); }
+
+  bool open(const std::string& fname){
+    mFile.open(fname, std::ios::binary | std::ios::trunc);
+    if (!mFile.is_open()) return false;
+    std::vector<char> buf(HEADER_MAGIC, HEADER_MAGIC+8);
+    PutLE<uint32_t>(buf, FORMAT_VERSION);
+    mFile.write(buf.data(), buf.size());
+    mOffset = buf.size();
+    mNSteps = 0;
+    mIndex.clear();
+    mBlock.clear();
+    return true;
+  }
+
+  // chips must be sorted, as returned by DeadMapSteps::getChips
+  void addStep(uint64_t orbit, const std::vector<uint16_t>& chips){
+    EncodeChips(chips, mWords);
+    addWords(orbit, mWords);
+  }
+
+  // words already in the interval encoding
+  void addWords(uint64_t orbit, const std::vector<uint16_t>& words){
+    if (mIndex.empty() || mIndex.back().nSteps == STEPS_PER_BLOCK){
+      flushBlock();
+      BlockIndex bi;
+      bi.firstOrbit = orbit;
+      bi.offset = mOffset;
+      bi.firstStep = mNSteps;
+      mIndex.push_back(bi);
+      PutVarint(mBlock, orbit);
+    }
+    else {
+      PutVarint(mBlock, orbit - mLastOrbit);
+    }
+    PutVarint(mBlock, words.size());
+    for (uint16_t w : words) PutLE<uint16_t>(mBlock, w);
+    mIndex.back().nSteps++;
+    mLastOrbit = orbit;
+    mNSteps++;
+  }
+
+  void close(){
+    if (!mFile.is_open()) return;
+    flushBlock();
+    std::vector<char> buf;
+    for (auto& bi : mIndex){
+      PutLE<uint64_t>(buf, bi.firstOrbit);
+      PutLE<uint64_t>(buf, bi.offset);
+      PutLE<uint32_t>(buf, bi.firstStep);
+      PutLE<uint32_t>(buf, bi.nSteps);
+    }
+    PutLE<uint64_t>(buf, mOffset);
+    PutLE<uint32_t>(buf, mIndex.size());
+    PutLE<uint64_t>(buf, mNSteps);
+    buf.insert(buf.end(), TRAILER_MAGIC, TRAILER_MAGIC+8);
+    mFile.write(buf.data(), buf.size());
+    mFile.close();
+  }
+
+  uint64_t size() const { return mNSteps; }
+
+private:
+  void flushBlock(){
+    mFile.write(mBlock.data(), mBlock.size());
+    mOffset += mBlock.size();
+    mBlock.clear();
+  }
+
+  std::ofstream mFile;
+  std::vector<char> mBlock;
+  std::vector<BlockIndex> mIndex;
+  std::vector<uint16_t> mWords;
+  uint64_t mOffset = 0;
+  uint64_t mNSteps = 0;
+  uint64_t mLastOrbit = 0;
+};
+
+
+class Reader {
+public:
+
+  bool open(const std::string& fname){
+    mIndex.clear();
+    mNSteps = 0;
+    mCachedBlock = -1;
+    mFile.close();
+    mFile.clear();
+    mFile.open(fname, std::ios::binary);
+    if (!mFile.is_open()) return false;
+    char head[12];
+    const int trailerSize = 8+4+8+8;
+    char trailer[trailerSize];
+    mFile.seekg(0, std::ios::end);
+    uint64_t fsize = mFile.tellg();
+    if (fsize < sizeof(head) + trailerSize) return false;
+    mFile.seekg(0);
+    mFile.read(head, sizeof(head));
+    mFile.seekg(fsize - trailerSize);
+    mFile.read(trailer, trailerSize);
+    if (!mFile) return false;
+    if (memcmp(head, HEADER_MAGIC, 8) != 0 || memcmp(trailer+20, TRAILER_MAGIC, 8) != 0) return false;
+    if (GetLE<uint32_t>(head+8) != FORMAT_VERSION) return false;
+    uint64_t indexOffset = GetLE<uint64_t>(trailer);
+    uint32_t nBlocks = GetLE<uint32_t>(trailer+8);
+    uint64_t nSteps = GetLE<uint64_t>(trailer+12);
+    // the index sits between the blocks and the trailer
+    if (indexOffset < sizeof(head) || indexOffset > fsize - trailerSize || (fsize - trailerSize - indexOffset) != 24ULL*nBlocks) return false;
+    std::vector<char> buf(24ULL*nBlocks);
+    mFile.seekg(indexOffset);
+    mFile.read(buf.data(), buf.size());
+    if (!mFile) return false;
+    std::vector<BlockIndex> index(nBlocks);
+    uint64_t step = 0, offset = sizeof(head);
+    for (uint32_t ib = 0; ib < nBlocks; ib++){
+      const char *p = buf.data() + 24*ib;
+      index[ib].firstOrbit = GetLE<uint64_t>(p);
+      index[ib].offset = GetLE<uint64_t>(p+8);
+      index[ib].firstStep = GetLE<uint32_t>(p+16);
+      index[ib].nSteps = GetLE<uint32_t>(p+20);
+      // blocks are contiguous in step and in file order, and end before the index
+      if (index[ib].firstStep != step || index[ib].nSteps == 0 || index[ib].nSteps > STEPS_PER_BLOCK) return false;
+      if (index[ib].offset < offset || index[ib].offset >= indexOffset) return false;
+      if (ib > 0 && index[ib].firstOrbit < index[ib-1].firstOrbit) return false;
+      step += index[ib].nSteps;
+      offset = index[ib].offset + 1;
+    }
+    if (step != nSteps) return false;
+    mIndex.swap(index);
+    mNSteps = nSteps;
+    mIndexOffset = indexOffset;
+    return true;
+  }
+
+  uint64_t size() const { return mNSteps; }
+
+  // step by index. Returns false if out of range or if the block is corrupted
+  bool readStep(uint64_t istep, uint64_t& orbit, std::vector<uint16_t>& chips){
+    if (istep >= mNSteps) return false;
+    int ib = std::upper_bound(mIndex.begin(), mIndex.end(), istep, [](uint64_t s, const BlockIndex& b){ return s < b.firstStep; }) - mIndex.begin() - 1;
+    if (!loadBlock(ib)) return false;
+    orbit = mOrbits[istep - mIndex[ib].firstStep];
+    getChips(istep - mIndex[ib].firstStep, chips);
+    return true;
+  }
+
+  // step used for a given orbit: the last one with orbit <= requested orbit (the first one if none), as TimeDeadMap::getMapAtOrbit
+  bool readStepAtOrbit(uint64_t orbit, uint64_t& steporbit, std::vector<uint16_t>& chips){
+    if (mNSteps == 0) return false;
+    int ib = blockOfOrbit(orbit);
+    if (!loadBlock(ib)) return false;
+    int k = std::upper_bound(mOrbits.begin(), mOrbits.end(), orbit) - mOrbits.begin() - 1;
+    if (k < 0) k = 0;
+    steporbit = mOrbits[k];
+    getChips(k, chips);
+    return true;
+  }
+
+  // all the steps with first <= orbit <= last. Returns false if a block is corrupted
+  bool readOrbitRange(uint64_t first, uint64_t last, std::vector<uint64_t>& orbits, std::vector<std::vector<uint16_t>>& chips){
+    orbits.clear();
+    chips.clear();
+    if (mNSteps == 0 || last < first) return true;
+    for (int ib = blockOfOrbit(first); ib < (int)mIndex.size() && mIndex[ib].firstOrbit <= last; ib++){
+      if (!loadBlock(ib)) return false;
+      for (size_t k = 0; k < mOrbits.size(); k++){
+	if (mOrbits[k] < first || mOrbits[k] > last) continue;
+	orbits.push_back(mOrbits[k]);
+	chips.emplace_back();
+	getChips(k, chips.back());
+      }
+    }
+    return true;
+  }
+
+private:
+
+  int blockOfOrbit(uint64_t orbit) const {
+    int ib = std::upper_bound(mIndex.begin(), mIndex.end(), orbit, [](uint64_t o, const BlockIndex& b){ return o < b.firstOrbit; }) - mIndex.begin() - 1;
+    return std::max(ib, 0);
+  }
+
+  // false if the block cannot be read or its steps do not fit in it
+  bool loadBlock(int ib){
+    if (ib == mCachedBlock) return true;
+    mCachedBlock = -1;
+    uint64_t end = (ib+1 < (int)mIndex.size()) ? mIndex[ib+1].offset : mIndexOffset;
+    mBuffer.resize(end - mIndex[ib].offset);
+    mFile.clear();
+    mFile.seekg(mIndex[ib].offset);
+    mFile.read(mBuffer.data(), mBuffer.size());
+    if (!mFile) return false;
+    mOrbits.clear();
+    mWordBegin.clear();
+    mWordCount.clear();
+    const char *p = mBuffer.data(), *pend = mBuffer.data() + mBuffer.size();
+    uint64_t orbit = 0, v = 0, nw = 0;
+    for (uint32_t k = 0; k < mIndex[ib].nSteps; k++){
+      if (!GetVarint(p, pend, v)) return false;
+      orbit = (k == 0) ? v : orbit + v;
+      if (k == 0 && orbit != mIndex[ib].firstOrbit) return false;
+      mOrbits.push_back(orbit);
+      if (!GetVarint(p, pend, nw) || nw > (uint64_t)(pend - p)/2) return false;
+      mWordBegin.push_back(p);
+      mWordCount.push_back(nw);
+      p += 2*nw;
+    }
+    mCachedBlock = ib;
+    return true;
+  }
+
+  void getChips(size_t k, std::vector<uint16_t>& chips){
+    mWords.resize(mWordCount[k]);
+    for (size_t i = 0; i < mWords.size(); i++) mWords[i] = GetLE<uint16_t>(mWordBegin[k] + 2*i);
+    DecodeWords(mWords, chips);
+  }
+
+  std::ifstream mFile;
+  std::vector<BlockIndex> mIndex;
+  uint64_t mNSteps = 0;
+  uint64_t mIndexOffset = 0;
+  int mCachedBlock = -1;
+  std::vector<char> mBuffer;
+  std::vector<uint64_t> mOrbits;
+  std::vector<const char*> mWordBegin;
+  std::vector<uint64_t> mWordCount;
+  std::vector<uint16_t> mWords;
+};
+
+} // namespace deadmapbin
+
+#endif
@@ -0,0 +1,21 @@
+//
+// Entry point and settings of the QA in DeadMapQA.C, for code linking the compiled DeadMapQA library
+// (see CMakeLists.txt). The macro itself does not include this file: there the defaults of the
+// arguments are the settings at the top of DeadMapQA.C.
+//
+
+#ifndef DEAD_MAP_QA_H
+#define DEAD_MAP_QA_H
+
+#include <TString.h>
+
+extern TString InputFile;
+extern bool writeAuxiliaryFile;
+extern int mapSampling;
+extern bool streamingQA;
+extern int nImportThreads;
+extern bool ExitWhenFinish;
+
+void DeadMapQA(TString FILENAME, int runnumber, TString outdir, bool WriteAuxiliaryFile, int MapSampling, bool Streaming, int NThreads);
+
+#endif
@@ -0,0 +1,113 @@
+//
+// ITS geometry constants and chip -> lane -> stave -> layer -> QCFEE mapping tables
+//
+// Lanes are numbered as in the dead map: the 432 IB lanes have one chip each, the OB lanes have 7 chips,
+// in layer order, stave after stave. The tables are built at compile time, so the mapping functions
+// are single lookups and do not depend on the lane geometry being built.
+//
+
+#ifndef ITS_GEOMETRY_TABLES_H
+#define ITS_GEOMETRY_TABLES_H
+
+#include <cstdint>
+
+constexpr int NStaves[7] = { 12, 16, 20, 24, 30, 42, 48 };
+constexpr int NZElementsInHalfStave[7] =  {9,9,9, 4, 4, 7, 7};
+constexpr int NSegmentsStave[7] = {1, 1, 1, 4, 4, 4, 4};
+constexpr int NLanesPerStave[7] = {9, 9, 9, 16, 16, 28, 28};
+constexpr int NChipsPerLane[7] = {1, 1, 1, 7, 7, 7, 7};
+constexpr int NChipsPerLayer[7] = {12*9, 16*9, 20*9, 24*112, 30*112, 42*196, 48*196};
+constexpr int N_LANES_IB = 432;
+constexpr int N_LANES_ML = 864; // L3,4
+constexpr int N_LANES = 3816;
+constexpr int N_STAVES_IB = 12+16+20;
+constexpr int N_STAVES = 192;
+constexpr int N_CHIPS = 24120;
+constexpr int N_CHIPS_IB = N_LANES_IB;
+constexpr int LaneLayerBoundary[8] = { 0, 108, 252, 432, 816, 1296, 2472, 3816 };
+constexpr int StaveLayerBoundary[8] = { 0, 12, 28, 48, 72, 102, 144, 192 };
+constexpr int ChipLayerBoundary[8] = { 0, 108, 252, 432, 3120, 6480, 14712, 24120 };
+
+namespace itsgeo {
+
+// returned by the mappings below for an out of range lane, stave or chip id (-1 as uint16_t)
+constexpr uint16_t NoId = (uint16_t)-1;
+
+struct LaneTables {
+  uint8_t layer[N_LANES];
+  uint8_t stave[N_LANES];
+  uint8_t staveInLayer[N_LANES];
+  uint16_t laneInLayer[N_LANES];
+  uint16_t qcfee[N_LANES];
+};
+
+struct StaveTables {
+  uint8_t layer[N_STAVES];
+  uint16_t firstLane[N_STAVES];
+};
+
+constexpr LaneTables makeLaneTables(){
+  LaneTables t{};
+  int lay = 0;
+  for (int lane = 0; lane < N_LANES; lane++){
+    while (lane >= LaneLayerBoundary[lay+1]) lay++;
+    int laneinlayer = lane - LaneLayerBoundary[lay];
+    int staveinlayer = laneinlayer / NLanesPerStave[lay];
+    t.layer[lane] = lay;
+    t.laneInLayer[lane] = laneinlayer;
+    t.staveInLayer[lane] = staveinlayer;
+    t.stave[lane] = StaveLayerBoundary[lay] + staveinlayer;
+    // readout units: 3 IB lanes, 8 lanes in L3-4, 14 lanes in L5-6
+    if (lane < N_LANES_IB) t.qcfee[lane] = lane/3;
+    else if (lay <= 4) t.qcfee[lane] = N_LANES_IB/3 + (lane - N_LANES_IB)/8;
+    else t.qcfee[lane] = N_LANES_IB/3 + N_LANES_ML/8 + (lane - N_LANES_IB - N_LANES_ML)/14;
+  }
+  return t;
+}
+
+constexpr StaveTables makeStaveTables(){
+  StaveTables t{};
+  int lay = 0;
+  for (int stv = 0; stv < N_STAVES; stv++){
+    while (stv >= StaveLayerBoundary[lay+1]) lay++;
+    t.layer[stv] = lay;
+    t.firstLane[stv] = LaneLayerBoundary[lay] + (stv - StaveLayerBoundary[lay])*NLanesPerStave[lay];
+  }
+  return t;
+}
+
+inline constexpr LaneTables Lanes = makeLaneTables();
+inline constexpr StaveTables Staves = makeStaveTables();
+
+static_assert(Lanes.stave[N_LANES-1] == N_STAVES-1 && Lanes.layer[N_LANES-1] == 6, "inconsistent lane tables");
+static_assert(Staves.firstLane[N_STAVES-1] + NLanesPerStave[6] == N_LANES, "inconsistent stave tables");
+
+} // namespace itsgeo
+
+constexpr uint16_t LaneToLayer(uint16_t laneid) { return (laneid < N_LANES) ? itsgeo::Lanes.layer[laneid] : itsgeo::NoId; }
+constexpr uint16_t LaneToStave(uint16_t laneid) { return (laneid < N_LANES) ? itsgeo::Lanes.stave[laneid] : itsgeo::NoId; }
+constexpr uint16_t LaneToStaveInLayer(uint16_t laneid) { return (laneid < N_LANES) ? itsgeo::Lanes.staveInLayer[laneid] : itsgeo::NoId; }
+constexpr uint16_t LaneToLaneInLayer(uint16_t laneid) { return (laneid < N_LANES) ? itsgeo::Lanes.laneInLayer[laneid] : itsgeo::NoId; }
+constexpr uint16_t LaneToQCFEE(uint16_t laneid) { return (laneid < N_LANES) ? itsgeo::Lanes.qcfee[laneid] : itsgeo::NoId; }
+constexpr uint16_t StaveToLayer(uint16_t stv) { return (stv < N_STAVES) ? itsgeo::Staves.layer[stv] : itsgeo::NoId; }
+constexpr uint16_t FirstLaneOfStave(uint16_t stv) { return (stv < N_STAVES) ? itsgeo::Staves.firstLane[stv] : itsgeo::NoId; }
+constexpr uint16_t LastLaneOfStave(uint16_t stv) { return (stv < N_STAVES) ? itsgeo::Staves.firstLane[stv] + NLanesPerStave[itsgeo::Staves.layer[stv]] - 1 : itsgeo::NoId; }
+
+constexpr uint16_t ChipToLane(uint16_t chipid){
+  if (chipid >= N_CHIPS) return itsgeo::NoId;
+  return (chipid < N_LANES_IB) ? chipid : N_LANES_IB + (chipid - N_LANES_IB)/7;
+}
+
+constexpr uint16_t LaneToFirstChip(uint16_t laneid){
+  if (laneid >= N_LANES) return itsgeo::NoId;
+  return (laneid < N_LANES_IB) ? laneid : N_LANES_IB + 7*(laneid - N_LANES_IB);
+}
+
+constexpr uint16_t ChipToChipInLayer(uint16_t chipid){
+  if (chipid >= N_CHIPS) return itsgeo::NoId;
+  return chipid - ChipLayerBoundary[itsgeo::Lanes.layer[ChipToLane(chipid)]];
+}
+
+static_assert(LaneToStave(N_LANES) == itsgeo::NoId && StaveToLayer(N_STAVES) == itsgeo::NoId && ChipToLane(N_CHIPS) == itsgeo::NoId, "out of range ids must map to -1");
+
+#endif
@@ -0,0 +1,166 @@
+//
+// Orbit anchoring lookup over the keys of the time-evolving dead map
+//
+// The step used for an orbit is the one used by TimeDeadMap::getMapAtOrbit: the last key <= orbit,
+// or the first key for orbits before the start of the map. The orbit is anchorable if its distance
+// from that key is below the threshold (UnanchorableThreshold in DeadMapQA.C), so that a gap between
+// two keys contributes (gap - threshold) un-anchorable orbits, as counted by the QA.
+// As in getMapAtOrbit, the distance is the unsigned difference orbit - key: for orbits before the
+// first key it wraps to a huge value, and these orbits are never anchorable. test/OrbitAnchoringTest.cxx
+// checks the steps and the distances against getMapAtOrbit, including orbits before the first key.
+//
+// Single queries use an Eytzinger (breadth-first) copy of the keys, which keeps the first levels of
+// the search in a few cache lines. In batches, unsorted orbits are searched BATCH at a time with
+// interleaved descents, and sorted orbits with a short linear scan from the previous result.
+//
+
+#ifndef ORBIT_ANCHORING_H
+#define ORBIT_ANCHORING_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+class OrbitAnchoring {
+public:
+
+  static const int MAX_SCAN = 8; // keys scanned linearly in sorted batches before searching the tree
+  static const int BATCH = 16;   // interleaved searches in unsorted batches
+
+  struct Interval {
+    uint64_t first; // included
+    uint64_t last;  // excluded
+  };
+
+  OrbitAnchoring() {}
+  OrbitAnchoring(const std::vector<unsigned long>& keys, uint64_t threshold) { build(keys, threshold); }
+
+  // keys must be sorted, as returned by TimeDeadMap::getEvolvingMapKeys
+  void build(const std::vector<unsigned long>& keys, uint64_t threshold){
+    mKeys.assign(keys.begin(), keys.end());
+    mThreshold = threshold;
+    mTree.assign(mKeys.size()+1, 0);
+    mRank.assign(mKeys.size()+1, 0);
+    size_t i = 0;
+    fillTree(1, i);
+  }
+
+  size_t size() const { return mKeys.size(); }
+  uint64_t key(int step) const { return mKeys[step]; }
+  uint64_t threshold() const { return mThreshold; }
+
+  // index of the step used for orbit, -1 if there are no keys
+  int findStep(uint64_t orbit) const {
+    if (mKeys.empty()) return -1;
+    size_t n = mKeys.size();
+    size_t k = 1;
+    while (k <= n){
+      __builtin_prefetch(mTree.data() + std::min(16*k, n)); // four levels ahead
+      k = 2*k + (mTree[k] <= orbit);
+    }
+    k >>= __builtin_ffsll(~k); // first key > orbit, 0 if none
+    int step = (k == 0) ? n-1 : mRank[k]-1;
+    return std::max(step, 0);
+  }
+
+  // distance from the key of the step, as returned by TimeDeadMap::getMapAtOrbit (wraps before the first key, see the test)
+  uint64_t distance(uint64_t orbit, int step) const {
+    return orbit - mKeys[step];
+  }
+
+  bool isAnchorable(uint64_t orbit) const {
+    int step = findStep(orbit);
+    return step >= 0 && distance(orbit, step) < mThreshold;
+  }
+
+  // batch lookup: steps[i] is the step used for orbits[i], anchorable (if not null) flags each query
+  void findSteps(const uint64_t* orbits, size_t nq, int* steps, char* anchorable = nullptr) const {
+    if (mKeys.empty()){
+      std::fill(steps, steps+nq, -1);
+      if (anchorable) std::fill(anchorable, anchorable+nq, false);
+      return;
+    }
+    if (std::is_sorted(orbits, orbits+nq)){
+      // sequential queries: move forward from the previous step
+      int step = findStep(orbits[0]);
+      steps[0] = step;
+      for (size_t j = 1; j < nq; j++){
+	int stop = step + MAX_SCAN;
+	while (step+1 < (int)mKeys.size() && mKeys[step+1] <= orbits[j] && step < stop) step++;
+	if (step == stop) step = findStep(orbits[j]); // large jump
+	steps[j] = step;
+      }
+    }
+    else {
+      // random queries: BATCH searches descend the tree together, to overlap their cache misses
+      size_t q = 0;
+      for (; q + BATCH <= nq; q += BATCH) findStepsInterleaved(orbits+q, steps+q);
+      for (; q < nq; q++) steps[q] = findStep(orbits[q]);
+    }
+    if (anchorable){
+      for (size_t q = 0; q < nq; q++) anchorable[q] = distance(orbits[q], steps[q]) < mThreshold;
+    }
+  }
+
+  void findSteps(const std::vector<uint64_t>& orbits, std::vector<int>& steps, std::vector<char>* anchorable = nullptr) const {
+    steps.resize(orbits.size());
+    if (anchorable) anchorable->resize(orbits.size());
+    findSteps(orbits.data(), orbits.size(), steps.data(), anchorable ? anchorable->data() : nullptr);
+  }
+
+  // dead lanes of the step used for orbit, from per-step lane bitsets of "stride" words each
+  // (e.g. MAP.laneBits and N_LANE_WORDS in DeadMapQA.C). nullptr if there are no keys
+  const uint64_t* deadLanes(const uint64_t* laneBits, size_t stride, uint64_t orbit) const {
+    int step = findStep(orbit);
+    return (step < 0) ? nullptr : laneBits + step*stride;
+  }
+
+  // anchorable and un-anchorable orbit intervals from the first to the last key
+  void intervals(std::vector<Interval>& anchorable, std::vector<Interval>& unanchorable) const {
+    anchorable.clear();
+    unanchorable.clear();
+    if (mKeys.empty()) return;
+    uint64_t start = mKeys[0];
+    for (size_t i = 0; i+1 < mKeys.size(); i++){
+      if (mKeys[i+1] - mKeys[i] <= mThreshold) continue;
+      uint64_t stop = mKeys[i] + mThreshold;
+      if (stop > start) anchorable.push_back({start, stop});
+      unanchorable.push_back({stop, mKeys[i+1]});
+      start = mKeys[i+1];
+    }
+    anchorable.push_back({start, mKeys.back()+1});
+  }
+
+private:
+
+  void findStepsInterleaved(const uint64_t* orbits, int* steps) const {
+    size_t n = mKeys.size();
+    size_t k[BATCH];
+    std::fill(k, k+BATCH, 1);
+    for (size_t level = 1; level <= n; level *= 2){
+      for (int b = 0; b < BATCH; b++){
+	if (k[b] <= n) k[b] = 2*k[b] + (mTree[k[b]] <= orbits[b]);
+      }
+    }
+    for (int b = 0; b < BATCH; b++){
+      k[b] >>= __builtin_ffsll(~k[b]);
+      steps[b] = (k[b] == 0) ? n-1 : std::max(mRank[k[b]]-1, 0);
+    }
+  }
+
+  // in-order visit of the implicit tree: the sorted keys end up in breadth-first order
+  void fillTree(size_t k, size_t& i){
+    if (k > mKeys.size()) return;
+    fillTree(2*k, i);
+    mTree[k] = mKeys[i];
+    mRank[k] = i++;
+    fillTree(2*k+1, i);
+  }
+
+  std::vector<uint64_t> mKeys;
+  std::vector<uint64_t> mTree; // 1-based Eytzinger layout
+  std::vector<int> mRank;      // index in mKeys of each tree node
+  uint64_t mThreshold = 0;
+};
+
+#endif
@@ -0,0 +1,38 @@
+//
+// Standalone QA of a time-evolving dead map, linked against the compiled DeadMapQA library.
+// Same arguments and output as the macro:
+//    deadmapqa <map file> [run] [outdir] [WriteAuxiliaryFile] [MapSampling] [Streaming] [NThreads]
+// is equivalent to
+//    root -b -q 'DeadMapQA.C("<map file>", run, "outdir", WriteAuxiliaryFile, MapSampling, Streaming, NThreads)'
+//
+
+#include <cstdlib>
+#include <iostream>
+
+#include <TROOT.h>
+
+#include "DeadMapQA.h"
+
+int main(int argc, char **argv){
+
+  if (argc < 2 || TString(argv[1]) == "-h" || TString(argv[1]) == "--help"){
+    std::cout<<"Usage: "<<argv[0]<<" <map file> [run = -1] [outdir = ./] [WriteAuxiliaryFile = "<<writeAuxiliaryFile<<"] [MapSampling = "<<mapSampling<<"] [Streaming = "<<streamingQA<<"] [NThreads = "<<nImportThreads<<"]"<<std::endl;
+    std::cout<<"Use run = -999 for synthetic maps"<<std::endl;
+    return 1;
+  }
+
+  gROOT->SetBatch(kTRUE);
+
+  TString file = argv[1];
+  int run = (argc > 2) ? std::atoi(argv[2]) : -1;
+  TString outdir = (argc > 3) ? argv[3] : "./";
+  bool aux = (argc > 4) ? std::atoi(argv[4]) : writeAuxiliaryFile;
+  int sampling = (argc > 5) ? std::atoi(argv[5]) : mapSampling;
+  bool streaming = (argc > 6) ? std::atoi(argv[6]) : streamingQA;
+  int nthreads = (argc > 7) ? std::atoi(argv[7]) : nImportThreads;
+  if (!outdir.EndsWith("/")) outdir += "/";
+
+  DeadMapQA(file, run, outdir, aux, sampling, streaming, nthreads); // exits with the QA summary if ExitWhenFinish
+
+  return 0;
+}
@@ -28,6 +28,7 @@ targetdir = "none"
 
 bktokenfile = "token.dat"
 QAmacroTimeout = 120
+QAexecutable = "./build/deadmapqa" # compiled QA (see CMakeLists.txt). If missing, DeadMapQA.C runs in ROOT
 
 #______________________________________________________________________________
 #logger = Logger(logfile)
@@ -246,7 +247,11 @@ if __name__ == "__main__":
                 execute('mv '+qadir[:-1]+' '+bkqadir[:-1])
         
         execute('mkdir '+targetdir+'/ITSQA/')
-        rootcommand = ['root', '-b', 'DeadMapQA.C("'+targetdir+'/its_time_deadmap.root",'+str(run)+',"'+targetdir+'/ITSQA/")']
+        if os.path.exists(QAexecutable):
+            rootcommand = [QAexecutable, targetdir+'/its_time_deadmap.root', str(run), targetdir+'/ITSQA/']
+        else:
+            rootcommand = ['root', '-b', 'DeadMapQA.C("'+targetdir+'/its_time_deadmap.root",'+str(run)+',"'+targetdir+'/ITSQA/")']
+        LOG(INFO,'QA command:',' '.join(rootcommand))
         process = subprocess.Popen(rootcommand, stderr=subprocess.PIPE, stdout=subprocess.PIPE)
         stdout, stderr = process.communicate(timeout=QAmacroTimeout)
 
@@ -0,0 +1,66 @@
+//
+// Resolution of the object valid at a timestamp in a local cache of SimpleDeadMapCheck.C (offline mode):
+// where two cached validities overlap, the latest upload must win, as in the CCDB.
+//
+
+#include <cstdio>
+#include <filesystem>
+
+#include "SimpleDeadMapCheck.C"
+
+int nFailed = 0;
+
+void expect(bool ok, const char *what){
+  std::cout<<(ok ? "PASS " : "FAIL ")<<what<<std::endl;
+  if (!ok) nFailed++;
+}
+
+void touch(const std::string& dir, const std::string& path, const DeadMapSource::Validity& v){
+  std::string fname = DeadMapSource::fileName(dir, path, v);
+  std::filesystem::create_directories(std::filesystem::path(fname).parent_path());
+  std::ofstream(fname).close();
+}
+
+int main(){
+
+  std::string dir = (std::filesystem::temp_directory_path() / "DeadMapSourceTest").string();
+  std::filesystem::remove_all(dir);
+  std::string path = "ITS/Calib/TimeDeadMap";
+
+  // an old object with a long validity (e.g. a default map), then a newer upload for one run inside it
+  DeadMapSource::Validity old, run, fix;
+  old.from = 1000; old.until = 1000000; old.created = 10; old.id = "aaaa-0001";
+  run.from = 5000; run.until = 6000; run.created = 20; run.id = "bbbb-0002";
+  // a correction re-uploaded later with an earlier Valid-From
+  fix.from = 4000; fix.until = 5500; fix.created = 30; fix.id = "cccc-0003";
+  touch(dir, path, old);
+  touch(dir, path, run);
+
+  DeadMapSource::Validity v;
+  expect(DeadMapSource::parseFileName(std::filesystem::path(DeadMapSource::fileName(dir, path, run)).filename().string(), v) && v == run && v.created == run.created, "file name round trip");
+
+  expect(DeadMapSource::findInDir(dir, path, 2000) == old, "only the old object valid");
+  expect(DeadMapSource::findInDir(dir, path, 5200) == run, "newer upload wins over the old long validity");
+  expect(DeadMapSource::findInDir(dir, path, 7000) == old, "old object after the newer validity");
+
+  touch(dir, path, fix);
+  expect(DeadMapSource::findInDir(dir, path, 5200) == fix, "re-uploaded correction wins, despite the earlier Valid-From");
+  expect(DeadMapSource::findInDir(dir, path, 5700) == run, "newer upload outside the correction");
+  expect(!DeadMapSource::findInDir(dir, path, 2000000).isValid(), "no object valid");
+
+  DeadMapSource src("http://unused", dir, true);
+  expect(src.getValidity(path, 5200) == fix, "offline source resolves from the cache");
+
+  // file:// layout without upload times: the latest Valid-From wins
+  std::string local = dir + "/local";
+  DeadMapSource::Validity a, b;
+  a.from = 0; a.until = 100;
+  b.from = 50; b.until = 200;
+  touch(local, path, a);
+  touch(local, path, b);
+  expect(DeadMapSource::findInDir(local, path, 70) == b, "local directory: latest Valid-From wins");
+
+  std::filesystem::remove_all(dir);
+  std::cout<<(nFailed ? "FAILED" : "OK")<<std::endl;
+  return nFailed ? 1 : 0;
+}
@@ -0,0 +1,70 @@
+//
+// OrbitAnchoring.h against TimeDeadMap::getMapAtOrbit: same step and same distance for every orbit,
+// including orbits before the first key, which must never be anchorable.
+//
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "OrbitAnchoring.h"
+#include "DataFormatsITSMFT/TimeDeadMap.h"
+
+int nFailed = 0;
+
+void expect(bool ok, const char *what){
+  std::cout<<(ok ? "PASS " : "FAIL ")<<what<<std::endl;
+  if (!ok) nFailed++;
+}
+
+int main(){
+
+  const uint64_t threshold = 330000; // as UnanchorableThreshold in DeadMapQA.C
+  const size_t stride = 3;
+
+  // keys with nominal gaps and one gap above the threshold. The map word of each step is its index
+  std::vector<unsigned long> keys = { 1000000, 1012160, 1024320, 1500000, 1512160 };
+  o2::itsmft::TimeDeadMap map;
+  for (size_t i = 0; i < keys.size(); i++) map.fillMap(keys[i], std::vector<uint16_t>(1, i));
+  OrbitAnchoring anchoring(map.getEvolvingMapKeys(), threshold);
+  std::vector<uint64_t> laneBits(keys.size()*stride);
+
+  std::vector<uint64_t> orbits = { 0, 1, keys[0] - threshold - 1, keys[0] - threshold, keys[0] - 1, keys[0], keys[0] + 1,
+				   keys[2] + threshold - 1, keys[2] + threshold, keys[3] - 1, keys[3], keys.back() + threshold };
+  std::mt19937_64 rng(1);
+  for (int i = 0; i < 1000; i++) orbits.push_back(rng() % (keys.back() + 2*threshold));
+
+  long nstep = 0, ndist = 0, nanch = 0, nlanes = 0, nbefore = 0;
+  std::vector<uint16_t> words;
+  for (uint64_t orbit : orbits){
+    unsigned long d = map.getMapAtOrbit(orbit, words);
+    int step = anchoring.findStep(orbit);
+    nstep += (step != words[0]);
+    ndist += (anchoring.distance(orbit, step) != d);
+    nanch += (anchoring.isAnchorable(orbit) != (d < threshold));
+    nlanes += (anchoring.deadLanes(laneBits.data(), stride, orbit) != laneBits.data() + words[0]*stride);
+    nbefore += (orbit < keys[0] && anchoring.isAnchorable(orbit));
+  }
+  expect(nstep == 0, "same step as getMapAtOrbit");
+  expect(ndist == 0, "same distance as getMapAtOrbit");
+  expect(nanch == 0, "anchorable if the getMapAtOrbit distance is below the threshold");
+  expect(nbefore == 0, "orbits before the first key are not anchorable");
+  expect(nlanes == 0, "dead lanes of the step");
+
+  std::vector<int> steps;
+  std::vector<char> anchorable;
+  long nbatch = 0;
+  for (int sorted = 0; sorted < 2; sorted++){
+    if (sorted) std::sort(orbits.begin(), orbits.end());
+    anchoring.findSteps(orbits, steps, &anchorable);
+    for (size_t i = 0; i < orbits.size(); i++) nbatch += (steps[i] != anchoring.findStep(orbits[i])) || (anchorable[i] != anchoring.isAnchorable(orbits[i]));
+  }
+  expect(nbatch == 0, "batch lookup, random and sorted orbits");
+
+  OrbitAnchoring empty(std::vector<unsigned long>(), threshold);
+  expect(empty.findStep(keys[0]) == -1 && !empty.isAnchorable(keys[0]) && empty.deadLanes(laneBits.data(), stride, keys[0]) == nullptr, "no keys");
+
+  std::cout<<(nFailed ? "FAILED" : "OK")<<std::endl;
+  return nFailed ? 1 : 0;
+}